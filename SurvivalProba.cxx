@@ -0,0 +1,386 @@
+// Survival probabilities of unstable particles : computation library, without ROOT (see SurvivalProba.h)
+
+#include "SurvivalProba.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+int FindDecayType(const char *ch_Part){
+    // "kLambdaFromXi", ... -> gkDecayType ; -1 if unknown
+    for(int iPart = 0; iPart < nPartDecayType; iPart++)
+        if( !strcmp(ch_Part, gkDecayChains[iPart].fEnumName) ) return iPart;
+    return -1;
+}
+
+int GetDecayConstants(short lDecayType, double p, double &a, double &b){
+    
+    // Decay constants per unit of length (m^-1), for a (mother) momentum p in GeV/c :
+    //   a = m / (cTau . p) of the decaying particle (the mother in the cascade cases),
+    //   b = same for the Lambda daughter, which carries a fraction f of p (cascade cases only, b = 0 otherwise).
+    // Returns the number of generations : 2 (cascade), 1 (single decay), 0 (unknown type).
+    
+    a = -1.;
+    b =  0.;
+    if(lDecayType < 0 || lDecayType >= nPartDecayType) return 0;
+    
+    const DecayChainInfo &lInfo = gkDecayChains[lDecayType];
+    
+    a = lInfo.fMass / (lInfo.fCTau * p);
+    if(lInfo.fDaughterPFraction <= 0.) return 1;
+    
+    b = lInfo.fMassDaughter / (lInfo.fCTauDaughter * lInfo.fDaughterPFraction * p);
+    return 2;
+}
+
+double dProba_dlxi(double *x, double *par){
+    
+    
+    double Lo  = par[0];
+    double pPart = par[1];  // momentum of the mother particle (Omega, Xi) in the cascade cases, of the single-decay particle otherwise
+    
+    short lDecayType = par[2]; // kLambdaFromXi, kLambdaFromOmega, kLambda, ...
+    
+    double Lxi   = x[0];  // decay length of the mother in the cascade cases, of the particle otherwise
+    
+    
+    // NOTE 1
+    // Pour les cas, kLambdaFromXi et kLambdaFromOmega,
+    // voir les hypothèses du chap. 5 thèse, 
+    // http://cdsweb.cern.ch/record/1490315
+    // NOTE 2
+    // Numériquement, attention : il ne faut pas oublier le facteur 1/c qui traine.
+    // --> tau devient c.Tau, dans la formule de probabilité de survie du PDG, 
+    
+    double a = -1;
+    double b = -1;
+    
+    switch( GetDecayConstants(lDecayType, pPart, a, b) ){
+        case 2 :    // calcul de l'intégrande
+            return std::exp(-a * Lxi) * a * std::exp( -b * (Lo-Lxi) );
+        case 1 :
+            return std::exp(-a * Lxi);
+    } // end switch 
+    
+    return -1;
+  
+    
+}
+
+double SurvivalProbaCascade(double Lo, double pMother, short lDecayType){
+    
+    // Closed form of the integral of dProba_dlxi over [0, Lo], for the cascade cases (see CascadeClosedForm)
+    
+    double a = -1;
+    double b = -1;
+    
+    if( GetDecayConstants(lDecayType, pMother, a, b) != 2 ){
+        fprintf(stderr, "SurvivalProbaCascade : not a cascade case [%d]... return -1 !\n", lDecayType);
+        return -1;
+    }
+    
+    return CascadeClosedForm(a, b, Lo);
+}
+
+int RunSurvivalTask(SurvivalTask &lTask){
+    
+    // Thread-safe : only the batch kernel, on the task own buffers
+    
+    int lNbPoint = lTask.fArLo.size();
+    for(int iPoint = 0; iPoint < lNbPoint; iPoint++) lTask.fArLo[iPoint] = lTask.fLoMax/lNbPoint * iPoint;
+    
+    lTask.fStatus = ComputeSurvivalGrid(lTask.fDecayType, &lTask.fP, 1, lTask.fArLo.data(), lNbPoint, lTask.fArProba.data());
+    return lTask.fStatus;
+}
+
+int RunSurvivalTasks(std::vector<SurvivalTask> &lTasks, int lNThreads){
+    
+    // Parallel sweep over the tasks : the workers pick the next task index from a shared counter,
+    // the results stay in lTasks[i], so the output ordering does not depend on the scheduling.
+    // lNThreads <= 0 : as many threads as hardware threads.
+    
+    if(lNThreads <= 0) lNThreads = std::thread::hardware_concurrency();
+    if(lNThreads <= 0) lNThreads = 1;
+    if(lNThreads > (int)lTasks.size()) lNThreads = lTasks.size();
+    
+    std::atomic<int> lNextTask(0);
+    
+    auto lWorker = [&lTasks, &lNextTask](){
+        for(int iTask = lNextTask++; iTask < (int)lTasks.size(); iTask = lNextTask++)
+            RunSurvivalTask(lTasks[iTask]);
+    };
+    
+    std::vector<std::thread> lThreads;
+    for(int iThread = 1; iThread < lNThreads; iThread++) lThreads.push_back( std::thread(lWorker) );
+    lWorker();  // the calling thread works too
+    for(size_t iThread = 0; iThread < lThreads.size(); iThread++) lThreads[iThread].join();
+    
+    int lStatus = 1;
+    for(size_t iTask = 0; iTask < lTasks.size(); iTask++) if(lTasks[iTask].fStatus != 1) lStatus = 0;
+    return lStatus;
+}
+
+
+uint64_t SurvivalRegistryHash(){
+    
+    // FNV-1a over the physics constants of the registry (the display settings do not matter)
+    
+    uint64_t lHash = 14695981039346656037ULL;
+    for(int iPart = 0; iPart < nPartDecayType; iPart++){
+        const DecayChainInfo &lInfo = gkDecayChains[iPart];
+        double lConst[5] = { lInfo.fMass, lInfo.fCTau, lInfo.fMassDaughter, lInfo.fCTauDaughter, lInfo.fDaughterPFraction };
+        const unsigned char *lBytes = (const unsigned char *) lConst;
+        for(size_t iByte = 0; iByte < sizeof(lConst); iByte++){
+            lHash ^= lBytes[iByte];
+            lHash *= 1099511628211ULL;
+        }
+    }
+    return lHash ^ gkSurvivalTableVersion;
+}
+
+static double SurvivalTMax(short lDecayType){
+    
+    // t range : up to P negligible (~e^-40), the slowest exponential driving the tail
+    
+    double a = -1;
+    double b = -1;
+    if( GetDecayConstants(lDecayType, 1., a, b) == 2 && b < a ) return 40. * a / b;
+    return 40.;
+}
+
+double ExactSurvivalProba(short lDecayType, double p, double Lo){
+    if( !IsValidCandidate(p, Lo) ) return gkInvalidSurvivalProba;
+    double lProba = gkInvalidSurvivalProba;
+    SurvivalDispatch<0>::Eval(lDecayType, Lo, p, lProba);
+    return lProba;
+}
+
+double EvalSurvivalTable(const SurvivalTable &lTable, double p, double Lo){
+    
+    // Linear interpolation in t ; beyond fTMax (tail, P < e^-40) or invalid input, exact evaluation
+    
+    double x = Lo * lTable.fBlock.fRateA / p * lTable.fInvDT;
+    
+    if( !(x >= 0. && x < lTable.fBlock.fNT - 1) )   // also catches NaN, Lo < 0
+        return ExactSurvivalProba(lTable.fBlock.fDecayType, p, Lo);
+    
+    int    iT = (int) x;
+    double fx = x - iT;
+    const float *v = lTable.fValues + iT;
+    return v[0] + fx * (v[1] - v[0]);
+}
+
+double EvalSurvivalTables(const SurvivalTableSet &lSet, short lDecayType, double p, double Lo){
+    
+    // Per-candidate hot path : a misuse is reported once per process, then only the -1 is returned
+    
+    static std::atomic<bool> lMisuseReported(false);
+    
+    if(lDecayType < 0 || lDecayType >= nPartDecayType || lSet.fTables.size() != (size_t) nPartDecayType){
+        if( !lMisuseReported.exchange(true) )
+            fprintf(stderr, "EvalSurvivalTables : wrong particle type [%d] or tables not opened... return -1 (reported once) !\n", lDecayType);
+        return -1;
+    }
+    return EvalSurvivalTable(lSet.fTables[lDecayType], p, Lo);
+}
+
+static int CheckSurvivalTableTolerance(const char *ch_Caller, double lTolerance){
+    if(lTolerance >= gkSurvivalTableMinTolerance) return 1;     // also rejects NaN
+    fprintf(stderr, "%s : tolerance %.2e below the float resolution of the tables (%.0e)... exit !\n", 
+            ch_Caller, lTolerance, gkSurvivalTableMinTolerance);
+    return 0;
+}
+
+int BuildSurvivalTable(short lDecayType, double lTolerance, 
+                       SurvivalTable &lTable, std::vector<float> &lValues){
+    
+    // 1 = built within lTolerance ; 0 = wrong type, tolerance below float resolution or not reached
+    
+    if( !CheckSurvivalTableTolerance("BuildSurvivalTable", lTolerance) ) return 0;
+    
+    double a = -1;
+    double b = -1;
+    if( !GetDecayConstants(lDecayType, 1., a, b) ){
+        fprintf(stderr, "BuildSurvivalTable : wrong particle type [%d]... exit !\n", lDecayType);
+        return 0;
+    }
+    
+    SurvivalTableBlock &lBlock = lTable.fBlock;
+    lBlock.fDecayType = lDecayType;
+    lBlock.fNT        = 65;
+    lBlock.fTMax      = SurvivalTMax(lDecayType);
+    lBlock.fRateA     = a;
+    lBlock.fOffset    = 0;
+    
+    while(true){
+        
+        lTable.fInvDT = (lBlock.fNT - 1) / lBlock.fTMax;
+        double lDT    = 1. / lTable.fInvDT;
+        
+        // nodes, at p = 1 GeV/c : Lo = t / a
+        lValues.resize(lBlock.fNT);
+        for(int iT = 0; iT < lBlock.fNT; iT++) lValues[iT] = ExactSurvivalProba(lDecayType, 1., iT * lDT / a);
+        lTable.fValues = lValues.data();
+        
+        // interpolation error at the mid-points
+        lBlock.fMaxError = 0.;
+        for(int iT = 0; iT < lBlock.fNT - 1; iT++){
+            double Lo = (iT + 0.5) * lDT / a;
+            lBlock.fMaxError = std::max( lBlock.fMaxError, std::fabs( EvalSurvivalTable(lTable, 1., Lo) - ExactSurvivalProba(lDecayType, 1., Lo) ) );
+        }
+        
+        if(lBlock.fMaxError <= lTolerance) break;
+        if(2 * lBlock.fNT - 1 > gkSurvivalTableMaxNodes){
+            fprintf(stderr, "BuildSurvivalTable : %s, max. number of nodes reached, error = %.2e > tolerance = %.2e... exit !\n", 
+                   gkDecayChains[lDecayType].fName, lBlock.fMaxError, lTolerance);
+            return 0;
+        }
+        lBlock.fNT = 2 * lBlock.fNT - 1;
+    }// end refinement
+    
+    fprintf(stderr, "BuildSurvivalTable : %s, %d nodes in t, max. error = %.2e\n", 
+           gkDecayChains[lDecayType].fName, lBlock.fNT, lBlock.fMaxError);
+    return 1;
+}
+
+int WriteSurvivalTables(const char *ch_FileName, double lTolerance){
+    
+    std::vector<SurvivalTableBlock> lBlocks(nPartDecayType);
+    std::vector<std::vector<float> > lValues(nPartDecayType);
+    
+    uint64_t lOffset   = sizeof(SurvivalTableHeader) + nPartDecayType * sizeof(SurvivalTableBlock);
+    double   lMaxError = 0.;
+    for(int iPart = 0; iPart < nPartDecayType; iPart++){
+        SurvivalTable lTable;
+        if( !BuildSurvivalTable(iPart, lTolerance, lTable, lValues[iPart]) ) return 0;
+        lMaxError              = std::max(lMaxError, lTable.fBlock.fMaxError);
+        lBlocks[iPart]         = lTable.fBlock;
+        lBlocks[iPart].fOffset = lOffset;
+        lOffset += lValues[iPart].size() * sizeof(float);
+        lOffset  = (lOffset + 7) & ~7ULL;   // keep the next block 8-byte aligned
+    }
+    
+    SurvivalTableHeader lHeader;
+    memcpy(lHeader.fMagic, gkSurvivalTableMagic, sizeof(lHeader.fMagic));
+    lHeader.fVersion        = gkSurvivalTableVersion;
+    lHeader.fNSpecies       = nPartDecayType;
+    lHeader.fRegistryHash   = SurvivalRegistryHash();
+    lHeader.fMaxError       = lMaxError;
+    
+    // Written to a temporary file of the same directory, then renamed over ch_FileName : the swap is atomic,
+    // a file already mapped by another job is never truncated (its inode stays alive until unmapped),
+    // and concurrent rebuilds each rename a complete file.
+    std::vector<char> ch_TmpName( strlen(ch_FileName) + 8 );
+    snprintf(ch_TmpName.data(), ch_TmpName.size(), "%s.XXXXXX", ch_FileName);
+    
+    int   lFd   = mkstemp(ch_TmpName.data());
+    FILE *lFile = (lFd >= 0) ? fdopen(lFd, "wb") : 0;
+    if(!lFile){
+        fprintf(stderr, "WriteSurvivalTables : cannot create a temporary file for %s... exit !\n", ch_FileName);
+        if(lFd >= 0){ close(lFd); unlink(ch_TmpName.data()); }
+        return 0;
+    }
+    fchmod(lFd, 0644);      // mkstemp : 0600
+    
+    fwrite(&lHeader, sizeof(lHeader), 1, lFile);
+    fwrite(lBlocks.data(), sizeof(SurvivalTableBlock), nPartDecayType, lFile);
+    for(int iPart = 0; iPart < nPartDecayType; iPart++){
+        fseek(lFile, lBlocks[iPart].fOffset, SEEK_SET);
+        fwrite(lValues[iPart].data(), sizeof(float), lValues[iPart].size(), lFile);
+    }
+    
+    int lStatus = ( ferror(lFile) || fflush(lFile) || fsync(lFd) ) ? 0 : 1;
+    if( fclose(lFile) ) lStatus = 0;
+    if( lStatus && rename(ch_TmpName.data(), ch_FileName) ) lStatus = 0;
+    if(!lStatus){
+        fprintf(stderr, "WriteSurvivalTables : write error on %s\n", ch_FileName);
+        unlink(ch_TmpName.data());
+    }
+    return lStatus;
+}
+
+void CloseSurvivalTables(SurvivalTableSet &lSet){
+    if(lSet.fMapAddress) munmap(lSet.fMapAddress, lSet.fMapSize);
+    lSet.fMapAddress = 0;
+    lSet.fMapSize    = 0;
+    lSet.fTables.clear();
+}
+
+int MapSurvivalTables(const char *ch_FileName, double lTolerance, SurvivalTableSet &lSet){
+    
+    // 1 = mapped ; 0 = missing, unreadable or stale (other registry, version, or achieved error above lTolerance)
+    
+    lSet.fMapAddress = 0;
+    lSet.fMapSize    = 0;
+    lSet.fTables.clear();
+    if( !CheckSurvivalTableTolerance("MapSurvivalTables", lTolerance) ) return 0;
+    
+    int lFd = open(ch_FileName, O_RDONLY);
+    if(lFd < 0) return 0;
+    
+    struct stat lStat;
+    if( fstat(lFd, &lStat) || lStat.st_size < (off_t)(sizeof(SurvivalTableHeader) + nPartDecayType * sizeof(SurvivalTableBlock)) ){
+        close(lFd);
+        return 0;
+    }
+    
+    void *lAddress = mmap(0, lStat.st_size, PROT_READ, MAP_PRIVATE, lFd, 0);
+    close(lFd);
+    if(lAddress == MAP_FAILED) return 0;
+    
+    lSet.fMapAddress = lAddress;
+    lSet.fMapSize    = lStat.st_size;
+    
+    const SurvivalTableHeader *lHeader = (const SurvivalTableHeader *) lAddress;
+    if( memcmp(lHeader->fMagic, gkSurvivalTableMagic, sizeof(lHeader->fMagic))  || 
+        lHeader->fVersion       != gkSurvivalTableVersion   || 
+        lHeader->fNSpecies      != (uint32_t) nPartDecayType    || 
+        lHeader->fRegistryHash  != SurvivalRegistryHash()   ||
+        !(lHeader->fMaxError    <= lTolerance)              ){
+        CloseSurvivalTables(lSet);
+        return 0;
+    }
+    
+    const SurvivalTableBlock *lBlocks = (const SurvivalTableBlock *)(lHeader + 1);
+    lSet.fTables.resize(nPartDecayType);
+    for(int iPart = 0; iPart < nPartDecayType; iPart++){
+        SurvivalTable &lTable = lSet.fTables[iPart];
+        lTable.fBlock = lBlocks[iPart];
+        if( lTable.fBlock.fDecayType != iPart || lTable.fBlock.fNT < 2 || !(lTable.fBlock.fTMax > 0.) ||
+            !(lTable.fBlock.fMaxError <= lHeader->fMaxError) ||
+            lTable.fBlock.fOffset + (uint64_t) lTable.fBlock.fNT * sizeof(float) > lSet.fMapSize ){
+            CloseSurvivalTables(lSet);
+            return 0;
+        }
+        lTable.fInvDT  = (lTable.fBlock.fNT - 1) / lTable.fBlock.fTMax;
+        lTable.fValues = (const float *)( (const char *) lAddress + lTable.fBlock.fOffset );
+    }
+    
+    return 1;
+}
+
+int OpenSurvivalTables(SurvivalTableSet &lSet, const char *ch_FileName, double lTolerance){
+    
+    // Load the tables from the cache file, (re)building it first if missing or stale
+    
+    if( !CheckSurvivalTableTolerance("OpenSurvivalTables", lTolerance) ) return 0;
+    if( MapSurvivalTables(ch_FileName, lTolerance, lSet) ) return 1;
+    
+    fprintf(stderr, "OpenSurvivalTables : %s missing or stale, rebuilding the tables...\n", ch_FileName);
+    if( !WriteSurvivalTables(ch_FileName, lTolerance) ) return 0;
+    
+    // re-opened and re-checked : the file may have been replaced again by a concurrent rebuild
+    if( !MapSurvivalTables(ch_FileName, lTolerance, lSet) ){
+        fprintf(stderr, "OpenSurvivalTables : cannot map %s... exit !\n", ch_FileName);
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,281 @@
+#ifndef SURVIVALPROBA_H
+#define SURVIVALPROBA_H
+
+// Survival probabilities of unstable particles : computation library, without ROOT.
+//
+// Antonin Maire, 
+// Origin : PhD thesis, 2012
+//  See CDS reference : CERN-THESIS-2011-263
+//   https://cds.cern.ch/record/1490315/, section V.B-5, p.143-145
+//    and especially Fig. V.7
+//
+// Used by the plotting macro Root_ComputeSurvivalProbability.C, the tree macro Root_ApplySurvivalWeights.C
+// and the command line tool survivalproba (see SurvivalProbaCli.cxx).
+// Units : lengths in m, momenta in GeV/c, masses in GeV/c².
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+// Masses in Gev/c²
+constexpr double mOmega         = 1.67245 ;
+constexpr double mXi            = 1.32171 ;
+constexpr double mLambda        = 1.115683;
+constexpr double mK0s           = 0.497614;
+constexpr double mD0            = 1.86486 ;   
+constexpr double mDplus         = 1.86962 ;
+constexpr double mDSplus        = 1.96849 ;
+constexpr double mLambdaCplus   = 2.28646 ;
+constexpr double mPion          = 0.13957 ;   // bachelors of the cascade decays, for the toy MC (SurvivalProbaMC.h)
+constexpr double mKaon          = 0.493677;
+
+// mean lifetime in m
+constexpr double cTauOmega          = 0.02461;
+constexpr double cTauXi             = 0.0491 ;
+constexpr double cTauLambda         = 0.0789 ;
+constexpr double cTauK0s            = 0.026844;
+constexpr double cTauD0             = 122.9e-6;
+constexpr double cTauDplus          = 311.8e-6;
+constexpr double cTauDSplus         = 149.9e-6;
+constexpr double cTauLambdaCplus    = 59.9e-6;
+
+
+enum gkDecayType{
+    kLambdaFromXi = 0,
+    kLambdaFromOmega,
+    kLambda,
+    kK0s,
+    kXi,
+    kOmega,
+    kD0,
+    kDplus,
+    kDSplus,
+    kLambdaCplus,
+    nPartDecayType
+};
+
+
+// Registry of the decay chains : one entry per gkDecayType, in the same order.
+// To add a species : one value in gkDecayType + one entry here (+ its display entry in Root_ComputeSurvivalProbability.C).
+struct DecayChainInfo{
+    const char *fEnumName;            // name given as argument of the macro, e.g. "kLambdaFromXi"
+    const char *fName;                // short name, used in the printouts and object names
+    double      fMass;                // decaying particle (the mother, in the cascade cases), in GeV/c²
+    double      fCTau;                //   "        "        , in m
+    double      fMassDaughter;        // Lambda daughter in the cascade cases, 0 otherwise
+    double      fCTauDaughter;        //   "        "
+    double      fDaughterPFraction;   // fraction of the mother momentum carried by the daughter, 0 = single decay
+    double      fMassBachelor;        // other daughter of the cascade decay (two-body kinematics of the toy MC), 0 otherwise
+    double      fPCases[3];           // momenta of the illustration curves, in GeV/c (mother momentum for the cascades)
+    double      fLoMax;               // upper edge of the computed Lo range, in m
+};
+
+constexpr DecayChainInfo gkDecayChains[nPartDecayType] = {
+    // NOTE for the cascades, pXi/pOmega and not the Lambda momentum ; primary Lambda : diff with "Lambda in cascade" case = 0.85*pXi[0]
+    { "kLambdaFromXi",    "LambdaFromXi",    mXi,          cTauXi,          mLambda, cTauLambda, 0.85, mPion, { 1.0, 3.0,  8.0 }, 2.5 },
+    { "kLambdaFromOmega", "LambdaFromOmega", mOmega,       cTauOmega,       mLambda, cTauLambda, 0.66, mKaon, { 1.0, 3.0,  8.0 }, 2.5 },
+    { "kLambda",          "Lambda",          mLambda,      cTauLambda,      0.,      0.,         0.,   0.,    { 0.5, 3.0,  5.0 }, 2.5 },
+    { "kK0s",             "K0s",             mK0s,         cTauK0s,         0.,      0.,         0.,   0.,    { 2.0, 5.0, 10.0 }, 2.0 },
+    { "kXi",              "Xi",              mXi,          cTauXi,          0.,      0.,         0.,   0.,    { 0.5, 0.8,  1.0 }, 2.0 },
+    { "kOmega",           "Omega",           mOmega,       cTauOmega,       0.,      0.,         0.,   0.,    { 2.0, 5.0, 10.0 }, 2.0 },
+    { "kD0",              "D0",              mD0,          cTauD0,          0.,      0.,         0.,   0.,    { 2.0, 5.0, 10.0 }, 0.003 },
+    { "kDplus",           "Dplus",           mDplus,       cTauDplus,       0.,      0.,         0.,   0.,    { 2.0, 5.0, 10.0 }, 0.006 },
+    { "kDSplus",          "DSplus",          mDSplus,      cTauDSplus,      0.,      0.,         0.,   0.,    { 2.0, 5.0, 10.0 }, 0.003 },
+    { "kLambdaCplus",     "LambdaCplus",     mLambdaCplus, cTauLambdaCplus, 0.,      0.,         0.,   0.,    { 2.0, 5.0, 10.0 }, 0.0012 },
+};
+
+
+inline double CascadeClosedForm(double a, double b, double Lo){
+    
+    // Closed form of the integral of dProba_dlxi over [0, Lo], for the cascade cases.
+    // With  a = m(mother) / (cTau(mother) . pMother)
+    // and   b = m(Lambda) / (cTau(Lambda) . f . pMother), f = fraction of pMother carried by the Lambda,
+    //
+    //   P(L>Lo) = a/(a-b) . [ exp(-b.Lo) - exp(-a.Lo) ]          (Bateman, 2 generations)
+    //           = a.Lo.exp(-a.Lo)                                 (limit a = b)
+    //
+    // Numerically : written as a.exp(-lo.Lo).[1-exp(-(hi-lo).Lo)]/(hi-lo), lo = min(a,b), hi = max(a,b),
+    // so that there is no cancellation when a ~ b and no overflow for large Lo.
+    
+    double lo = (a < b) ? a : b;
+    double hi = (a < b) ? b : a;
+    double d  = (hi - lo) * Lo;
+    
+    if(d == 0.) return a * Lo * std::exp(-lo * Lo);                             // equal decay constants
+    
+    return a * std::exp(-lo * Lo) * ( -std::expm1(-d) ) / (hi - lo);
+}
+
+
+// Value returned for an invalid candidate (p <= 0, Lo < 0, NaN or infinite) by the per-candidate evaluations
+const double gkInvalidSurvivalProba = -1.;
+
+// Bit-level tests on the IEEE-754 representation, not floating-point comparisons : they keep their meaning
+// in code built with -ffast-math, where the compiler assumes no NaN / inf (std::isfinite folded to true).
+const uint64_t gkDoubleSignBit     = 0x8000000000000000ULL;
+const uint64_t gkDoubleExponentMax = 0x7ff0000000000000ULL;     // exponent of NaN and inf
+
+inline uint64_t DoubleBits(double x){
+    uint64_t lBits;
+    memcpy(&lBits, &x, sizeof(lBits));
+    return lBits;
+}
+
+inline bool IsValidMomentum(double p){      // p > 0, finite
+    uint64_t lBits = DoubleBits(p);
+    return !(lBits & gkDoubleSignBit) && lBits != 0 && (lBits & gkDoubleExponentMax) != gkDoubleExponentMax;
+}
+
+inline bool IsValidLength(double Lo){       // Lo >= 0 (-0 included), finite
+    uint64_t lBits = DoubleBits(Lo);
+    return ( !(lBits & gkDoubleSignBit) || lBits == gkDoubleSignBit ) && (lBits & gkDoubleExponentMax) != gkDoubleExponentMax;
+}
+
+inline bool IsValidCandidate(double p, double Lo){
+    return IsValidMomentum(p) && IsValidLength(Lo);
+}
+
+
+// Evaluation kernels, specialised at compile time per species from the registry :
+// no switch, no string comparison, the cascade/single-decay choice is a compile-time constant.
+// The batch loops over (p, Lo) built on the same rates are in SurvivalProbaBatch.cxx (fast-math, SIMD exp).
+template <int kType>
+struct SurvivalKernel{
+    
+    static constexpr double kRateA     = gkDecayChains[kType].fMass / gkDecayChains[kType].fCTau;     // m^-1 . GeV/c
+    static constexpr bool   kIsCascade = gkDecayChains[kType].fDaughterPFraction > 0.;
+    static constexpr double kRateB     = kIsCascade ? gkDecayChains[kType].fMassDaughter / (gkDecayChains[kType].fCTauDaughter * gkDecayChains[kType].fDaughterPFraction) : 0.;
+    
+    static double Eval(double Lo, double p){
+        if(kIsCascade) return CascadeClosedForm(kRateA/p, kRateB/p, Lo);
+        return std::exp( -kRateA/p * Lo );
+    }
+};
+
+// Run-time type -> SurvivalKernel<kType> : resolved once per call, never per point
+template <int kType>
+struct SurvivalDispatch{
+    static bool Eval(short lDecayType, double Lo, double p, double &lProba){
+        if(lDecayType == kType){ lProba = SurvivalKernel<kType>::Eval(Lo, p); return true; }
+        return SurvivalDispatch<kType+1>::Eval(lDecayType, Lo, p, lProba);
+    }
+};
+
+template <>
+struct SurvivalDispatch<nPartDecayType>{
+    static bool Eval(short, double, double, double &){ return false; }
+};
+
+
+// --- Evaluation
+
+int FindDecayType(const char *ch_Part);     // "kLambdaFromXi", ... -> gkDecayType ; -1 if unknown
+
+int GetDecayConstants(short lDecayType, double p, double &a, double &b);
+
+double dProba_dlxi(double *x, double *par);  // TF1-compatible : x[0] = decay length, par = { Lo, p, gkDecayType }
+
+double SurvivalProbaCascade(double Lo, double pMother, short lDecayType);
+
+double ExactSurvivalProba(short lDecayType, double p, double Lo);     // gkInvalidSurvivalProba if invalid (p, Lo) or type
+
+// Batch API (SurvivalProbaBatch.cxx) : invalid inputs as for ExactSurvivalProba, gkInvalidSurvivalProba
+// (whole row for an invalid p, whole column for an invalid Lo), counted in *nInvalid
+int ComputeSurvivalGrid(short lDecayType, 
+                        const double *lArP,  int nP, 
+                        const double *lArLo, int nLo, 
+                        double *lArSurvivalProba, long long *nInvalid = 0);
+
+int ComputeSurvivalPairs(short lDecayType, 
+                         const double *lArP, const double *lArLo, long long n, 
+                         double *lArSurvivalProba, long long *nInvalid = 0);     // invalid candidates : gkInvalidSurvivalProba, counted in *nInvalid
+
+
+// --- Parallel sweep
+
+// One curve = one (particle, momentum) case : all the state needed to compute it, owned by the task
+struct SurvivalTask{
+    short               fDecayType;   // gkDecayType
+    int                 fPtCase;      // index of the momentum case
+    double              fP;           // momentum in GeV/c (mother momentum for the cascade cases)
+    double              fLoMax;       // in meter
+    std::vector<double> fArLo;        // Lo values in meter
+    std::vector<double> fArProba;     // P(L>Lo)
+    int                 fStatus;      // 1 = ok, 0 = failure, -1 = not yet computed
+};
+
+int RunSurvivalTask(SurvivalTask &lTask);
+int RunSurvivalTasks(std::vector<SurvivalTask> &lTasks, int lNThreads);
+
+
+// --- Tables
+
+// Survival probability tables : P(L>Lo | p) tabulated per species, for fast per-candidate lookups.
+//
+// For all the registry species, the decay constants scale as 1/p : P only depends on t = Lo . a(p=1) / p
+// (Lo in units of the mean decay length of the decaying particle). One axis per species, nodes uniform
+// in t over [0, fTMax] (P < e^-40 beyond, exact evaluation there), linear interpolation : no
+// transcendental function per lookup. The number of nodes is doubled until the interpolation error,
+// checked against the exact kernel at the mid-points, is below the requested tolerance (values stored
+// as float : tolerances below gkSurvivalTableMinTolerance are rejected, and the build fails if the
+// tolerance is not reached within gkSurvivalTableMaxNodes nodes).
+// Worth it for the cascades (two exp + expm1 in the closed form) ; for the single decays the closed
+// form is one exp, the table is at best on par (see survivalproba_bench and the README).
+//
+// File layout (native endianness) : SurvivalTableHeader, nPartDecayType x SurvivalTableBlock,
+// then the float values of each block. The file is mmap-ed (private, read-only) at load time ;
+// it is rebuilt in a temporary file renamed over the old one, never rewritten in place.
+// The header carries a hash of the registry physics constants : changing a mass, a cTau or a
+// momentum fraction makes the file stale, and it is rebuilt by OpenSurvivalTables. It also carries the
+// worst interpolation error achieved over all the blocks, compared to the requested tolerance at load time.
+
+const uint32_t  gkSurvivalTableVersion  = 3;
+const char      gkSurvivalTableMagic[8] = "SPTABLE";
+const int       gkSurvivalTableMaxNodes = (1 << 22) + 1;
+const double    gkSurvivalTableMinTolerance = 1e-7;     // float resolution of the stored values
+
+struct SurvivalTableHeader{
+    char        fMagic[8];
+    uint32_t    fVersion;
+    uint32_t    fNSpecies;
+    uint64_t    fRegistryHash;
+    double      fMaxError;      // worst achieved interpolation error of the blocks, absolute, on P
+};
+
+struct SurvivalTableBlock{
+    int32_t     fDecayType;
+    int32_t     fNT;            // number of nodes along t
+    double      fTMax;
+    double      fRateA;         // a(p = 1 GeV/c), m^-1 : t = Lo . fRateA / p
+    double      fMaxError;      // achieved interpolation error
+    uint64_t    fOffset;        // of the values, in bytes from the beginning of the file
+};
+
+struct SurvivalTable{
+    SurvivalTableBlock  fBlock;
+    double              fInvDT;
+    const float        *fValues;    // fNT values, points into the mapped file (or the build storage)
+};
+
+struct SurvivalTableSet{
+    std::vector<SurvivalTable>  fTables;    // indexed by gkDecayType ; empty = not opened
+    void                       *fMapAddress = 0;
+    size_t                      fMapSize    = 0;
+};
+
+uint64_t SurvivalRegistryHash();
+
+double EvalSurvivalTable (const SurvivalTable    &lTable, double p, double Lo);
+double EvalSurvivalTables(const SurvivalTableSet &lSet,   short lDecayType, double p, double Lo);  // -1 if wrong type or set not opened (reported once)
+
+int BuildSurvivalTable(short lDecayType, double lTolerance, SurvivalTable &lTable, std::vector<float> &lValues);
+int WriteSurvivalTables(const char *ch_FileName, double lTolerance);
+int MapSurvivalTables  (const char *ch_FileName, double lTolerance, SurvivalTableSet &lSet);
+int OpenSurvivalTables (SurvivalTableSet &lSet, const char *ch_FileName = "SurvivalProbaTables.bin", double lTolerance = 1e-5);
+void CloseSurvivalTables(SurvivalTableSet &lSet);
+
+
+#endif // SURVIVALPROBA_H
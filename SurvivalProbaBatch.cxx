@@ -0,0 +1,159 @@
+// Survival probabilities of unstable particles : batch API of the library, ComputeSurvivalGrid and
+// ComputeSurvivalPairs (see SurvivalProba.h).
+//
+// This file alone is built with -ffast-math (CMake option SURVIVALPROBA_FAST_MATH, ON by default) :
+// with GCC and glibc, the contiguous exp loops below are then vectorised with the SIMD exp of libmvec.
+// The rest of the library keeps the IEEE semantics. Hence :
+//  - the kernels have internal linkage and do not call the inline floating-point functions of the header
+//    (CascadeClosedForm, SurvivalKernel::Eval), whose fast-math copies could otherwise be the ones kept
+//    by the linker for the other files ; only the constexpr rates of SurvivalKernel are shared,
+//  - the kernels run on all the points, then the invalid inputs are overwritten with gkInvalidSurvivalProba :
+//    the validity tests are bit-level (IsValidMomentum, IsValidLength), not affected by fast-math.
+
+#include "SurvivalProba.h"
+
+#include <cstdio>
+#include <vector>
+
+
+namespace{
+
+inline double BatchCascadeClosedForm(double a, double b, double Lo){
+
+    // Same as CascadeClosedForm (SurvivalProba.h), local to this file
+
+    double lo = (a < b) ? a : b;
+    double hi = (a < b) ? b : a;
+    double d  = (hi - lo) * Lo;
+
+    if(d == 0.) return a * Lo * std::exp(-lo * Lo);                             // equal decay constants
+
+    return a * std::exp(-lo * Lo) * ( -std::expm1(-d) ) / (hi - lo);
+}
+
+template <int kType>
+struct SurvivalBatchKernel{
+
+    typedef SurvivalKernel<kType> K;
+
+    static void EvalGrid(const double *lArP, int nP, const double *lArLo, int nLo, double *lArSurvivalProba){
+
+        for(int iP = 0; iP < nP; iP++){
+
+            double *lRow = lArSurvivalProba + (long long)iP * nLo;
+            double a     = K::kRateA / lArP[iP];
+
+            if(!K::kIsCascade){
+                for(int iLo = 0; iLo < nLo; iLo++) lRow[iLo] = std::exp( -a * lArLo[iLo] );
+                continue;
+            }
+
+            double b  = K::kRateB / lArP[iP];
+            double lo = (a < b) ? a : b;
+            double hi = (a < b) ? b : a;
+
+            if(hi - lo < 1e-3 * hi){
+                // (quasi-)equal decay constants : the difference of exponentials cancels, go through expm1
+                for(int iLo = 0; iLo < nLo; iLo++) lRow[iLo] = BatchCascadeClosedForm(a, b, lArLo[iLo]);
+                continue;
+            }
+
+            double lNorm = a / (hi - lo);
+            for(int iLo = 0; iLo < nLo; iLo++) lRow[iLo] = lNorm * ( std::exp( -lo * lArLo[iLo] ) - std::exp( -hi * lArLo[iLo] ) );
+
+        }// end loop momenta
+    }
+
+    static void EvalPairs(const double *lArP, const double *lArLo, long long n, double *lArSurvivalProba){
+
+        // one (p, Lo) per candidate
+        if(!K::kIsCascade){
+            for(long long i = 0; i < n; i++) lArSurvivalProba[i] = std::exp( -K::kRateA / lArP[i] * lArLo[i] );
+            return;
+        }
+        for(long long i = 0; i < n; i++) lArSurvivalProba[i] = BatchCascadeClosedForm(K::kRateA / lArP[i], K::kRateB / lArP[i], lArLo[i]);
+    }
+};
+
+// Run-time type -> SurvivalBatchKernel<kType> : resolved once per call, never per point
+template <int kType>
+struct SurvivalBatchDispatch{
+    static bool EvalGrid(short lDecayType, const double *lArP, int nP, const double *lArLo, int nLo, double *lArSurvivalProba){
+        if(lDecayType == kType){ SurvivalBatchKernel<kType>::EvalGrid(lArP, nP, lArLo, nLo, lArSurvivalProba); return true; }
+        return SurvivalBatchDispatch<kType+1>::EvalGrid(lDecayType, lArP, nP, lArLo, nLo, lArSurvivalProba);
+    }
+    static bool EvalPairs(short lDecayType, const double *lArP, const double *lArLo, long long n, double *lArSurvivalProba){
+        if(lDecayType == kType){ SurvivalBatchKernel<kType>::EvalPairs(lArP, lArLo, n, lArSurvivalProba); return true; }
+        return SurvivalBatchDispatch<kType+1>::EvalPairs(lDecayType, lArP, lArLo, n, lArSurvivalProba);
+    }
+};
+
+template <>
+struct SurvivalBatchDispatch<nPartDecayType>{
+    static bool EvalGrid(short, const double *, int, const double *, int, double *){ return false; }
+    static bool EvalPairs(short, const double *, const double *, long long, double *){ return false; }
+};
+
+}// end anonymous namespace
+
+
+int ComputeSurvivalGrid(short lDecayType,
+                        const double *lArP,  int nP,
+                        const double *lArLo, int nLo,
+                        double *lArSurvivalProba, long long *nInvalid){
+
+    // Batch evaluation of P(L>Lo) on a (momentum x Lo) grid, without TF1 :
+    //   lArP  [nP]          : momenta in GeV/c (mother momentum for the cascade cases)
+    //   lArLo [nLo]         : decay lengths in m
+    //   lArSurvivalProba    : output, nP x nLo values, row-major : [iP*nLo + iLo]
+    // Invalid p (<= 0, NaN, inf) : whole row at gkInvalidSurvivalProba ; invalid Lo (< 0, NaN, inf) : whole column.
+    //
+    // The particle type is resolved once, then branch-free and contiguous inner loops over Lo, vectorised.
+
+    if( !SurvivalBatchDispatch<0>::EvalGrid(lDecayType, lArP, nP, lArLo, nLo, lArSurvivalProba) ){
+        fprintf(stderr, "ComputeSurvivalGrid : wrong particle type [%d]... exit !\n", lDecayType);
+        return 0;
+    }
+
+    // Lo checked once for all the rows : nothing more to do in the usual case
+    std::vector<int> lArInvalidLo;
+    for(int iLo = 0; iLo < nLo; iLo++) if( !IsValidLength(lArLo[iLo]) ) lArInvalidLo.push_back(iLo);
+
+    long long lNInvalid = 0;
+    for(int iP = 0; iP < nP; iP++){
+        double *lRow = lArSurvivalProba + (long long)iP * nLo;
+        if( !IsValidMomentum(lArP[iP]) ){
+            for(int iLo = 0; iLo < nLo; iLo++) lRow[iLo] = gkInvalidSurvivalProba;
+            lNInvalid += nLo;
+            continue;
+        }
+        for(size_t iInvalid = 0; iInvalid < lArInvalidLo.size(); iInvalid++) lRow[ lArInvalidLo[iInvalid] ] = gkInvalidSurvivalProba;
+        lNInvalid += lArInvalidLo.size();
+    }
+    if(nInvalid) *nInvalid = lNInvalid;
+
+    return 1;
+}
+
+int ComputeSurvivalPairs(short lDecayType,
+                         const double *lArP, const double *lArLo, long long n,
+                         double *lArSurvivalProba, long long *nInvalid){
+
+    // Batch evaluation of P(L>Lo) for n candidates : lArSurvivalProba[i] = P(L > lArLo[i] | lArP[i]),
+    // gkInvalidSurvivalProba (-1) for p <= 0, Lo < 0, NaN or infinite input ; no message per candidate
+
+    if( !SurvivalBatchDispatch<0>::EvalPairs(lDecayType, lArP, lArLo, n, lArSurvivalProba) ){
+        fprintf(stderr, "ComputeSurvivalPairs : wrong particle type [%d]... exit !\n", lDecayType);
+        return 0;
+    }
+
+    long long lNInvalid = 0;
+    for(long long i = 0; i < n; i++){
+        if( IsValidCandidate(lArP[i], lArLo[i]) ) continue;
+        lArSurvivalProba[i] = gkInvalidSurvivalProba;
+        lNInvalid++;
+    }
+    if(nInvalid) *nInvalid = lNInvalid;
+
+    return 1;
+}
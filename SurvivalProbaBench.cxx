@@ -0,0 +1,462 @@
+// survivalproba_bench : timing and accuracy harness of the SurvivalProba kernels, without ROOT.
+//
+// Timing   : evaluations/sec of each path, per species and Lo grid size (registry momenta, Lo in [0, LoMax]).
+// Accuracy : each path against a reference evaluated in long double with an independent formulation
+//            (difference of exponentials, Taylor series when the decay constants are close),
+//            on the registry grid and on edge cases : Lo = 0, very large Lo, lengths at the scale of
+//            the decay length (micrometres for the D mesons), equal decay constants, and invalid
+//            candidates (p <= 0, Lo < 0, NaN, +-inf -> -1).
+//
+// Output : CSV, one line per record, to be diffed / tracked between versions
+//   record,path,type,case,n,evals_per_sec,max_abs_err,max_rel_err,status
+// The exit code is 3 if an accuracy check fails.
+//
+//   survivalproba_bench -o bench.csv
+//   survivalproba_bench -t kLambdaFromXi -t kD0 -n 500,100000 --min-time 0.2
+//
+// The TF1 paths (TF1::Eval, TF1::Integral) are timed by Root_BenchSurvivalProba.C, same CSV columns.
+
+#include "SurvivalProba.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+enum gkBenchPath{
+    kPathExact = 0,     // ExactSurvivalProba, one call per point
+    kPathGrid,          // ComputeSurvivalGrid, one call per curve set
+    kPathPairs,         // ComputeSurvivalPairs, one call for all the points
+    kPathTable,         // EvalSurvivalTables, one call per point
+    kPathIntegrand,     // dProba_dlxi (the function behind the TF1), one call per point ; timing only
+    nBenchPath
+};
+
+static const char *gkBenchPathName[nBenchPath] = { "ExactSurvivalProba", "ComputeSurvivalGrid", "ComputeSurvivalPairs", "EvalSurvivalTables", "dProba_dlxi" };
+
+static FILE          *gBenchFile  = 0;
+static volatile double gBenchSink = 0.;     // keeps the timed loops alive
+
+
+static void PrintUsage(const char *ch_Name){
+    printf("Usage : %s [options]\n", ch_Name);
+    printf("  -t, --type NAME       species (repeatable, default : all)\n");
+    printf("  -n, --npoint LIST     comma-separated Lo grid sizes of the timing (default : 100,500,10000,1000000)\n");
+    printf("      --min-time S      minimal duration of each timing, in s (default : 0.05)\n");
+    printf("      --table FILE      lookup-table cache (default : SurvivalProbaTables.bin)\n");
+    printf("      --tolerance X     tolerance of the tables, >= 1e-7 (default : 1e-5)\n");
+    printf("      --no-timing       accuracy checks only\n");
+    printf("  -o, --output FILE     CSV output (default : stdout)\n");
+    printf("  -h, --help\n");
+}
+
+static bool ParseSizes(const char *ch_List, std::vector<int> &lArN){
+    std::string lList(ch_List);
+    size_t lStart = 0;
+    while(lStart <= lList.size()){
+        size_t lEnd = lList.find(',', lStart);
+        if(lEnd == std::string::npos) lEnd = lList.size();
+        char *lParsed = 0;
+        std::string lItem = lList.substr(lStart, lEnd - lStart);
+        long n = strtol(lItem.c_str(), &lParsed, 10);
+        if(lItem.empty() || *lParsed != '\0' || n <= 0) return false;
+        lArN.push_back((int) n);
+        lStart = lEnd + 1;
+    }
+    return !lArN.empty();
+}
+
+static bool ParseReal(const char *ch_Value, double &lValue){
+    char *lParsed = 0;
+    double x = strtod(ch_Value, &lParsed);
+    if(lParsed == ch_Value || *lParsed != '\0' || !std::isfinite(x)) return false;
+    lValue = x;
+    return true;
+}
+
+
+// --- Reference
+
+static long double ReferenceCascade(long double a, long double b, long double Lo){
+
+    //   P(L>Lo) = a/(hi-lo) . [ exp(-lo.Lo) - exp(-hi.Lo) ]
+    //           = a.Lo.exp(-lo.Lo) . (1-exp(-x))/x,  x = (hi-lo).Lo,  Taylor series for small x
+
+    long double lo = (a < b) ? a : b;
+    long double hi = (a < b) ? b : a;
+    long double x  = (hi - lo) * Lo;
+
+    if(x < 0.05L){
+        long double lSum  = 0.L;
+        long double lTerm = 1.L;
+        for(int k = 1; k < 30 && std::fabs(lTerm) > 1e-22L; k++){
+            lSum  += lTerm;
+            lTerm *= -x / (k + 1);
+        }
+        return a * Lo * std::exp(-lo * Lo) * lSum;
+    }
+    return a / (hi - lo) * ( std::exp(-lo * Lo) - std::exp(-hi * Lo) );
+}
+
+static long double ReferenceSurvivalProba(short lDecayType, double p, double Lo){
+
+    const DecayChainInfo &lInfo = gkDecayChains[lDecayType];
+
+    long double a = (long double) lInfo.fMass / ( (long double) lInfo.fCTau * p );
+    if(lInfo.fDaughterPFraction <= 0.) return std::exp(-a * Lo);
+
+    long double b = (long double) lInfo.fMassDaughter / ( (long double) lInfo.fCTauDaughter * lInfo.fDaughterPFraction * p );
+    return ReferenceCascade(a, b, Lo);
+}
+
+
+// --- Accuracy
+
+struct AccuracyStat{
+    long long   fN;
+    long long   fNFail;
+    double      fMaxAbs;
+    double      fMaxRel;
+
+    AccuracyStat() : fN(0), fNFail(0), fMaxAbs(0.), fMaxRel(0.) {}
+
+    void Add(double lValue, long double lRef, double lAbsTol, double lRelTol){
+        fN++;
+        if( !(lValue >= 0. && lValue <= 1.) ){ fNFail++; fMaxAbs = fMaxRel = HUGE_VAL; return; }  // also NaN
+
+        double lAbs = (double) std::fabs(lValue - lRef);
+        if(lAbs > fMaxAbs) fMaxAbs = lAbs;
+        if(lRef > 1e-290L){
+            double lRel = (double) (lAbs / lRef);
+            if(lRel > fMaxRel) fMaxRel = lRel;
+        }
+        if(lAbs > lAbsTol + lRelTol * (double) lRef) fNFail++;
+    }
+};
+
+static void PrintAccuracy(const char *ch_Path, const char *ch_Type, const char *ch_Case, const AccuracyStat &lStat){
+    fprintf(gBenchFile, "accuracy,%s,%s,%s,%lld,,%.3g,%.3g,%s\n",
+            ch_Path, ch_Type, ch_Case, lStat.fN, lStat.fMaxAbs, lStat.fMaxRel, lStat.fNFail ? "fail" : "pass");
+}
+
+// One check : grid of momenta x Lo, every path against the reference
+static int CheckSpecies(short lDecayType, const char *ch_Case,
+                        const std::vector<double> &lArP, const std::vector<double> &lArLo,
+                        const SurvivalTableSet &lSet, double lTableTol){
+
+    int nP  = lArP .size();
+    int nLo = lArLo.size();
+    long long n = (long long) nP * nLo;
+
+    std::vector<long double> lArRef(n);
+    std::vector<double>      lArPairP(n), lArPairLo(n), lArGrid(n), lArPairs(n);
+    for(int iP = 0; iP < nP; iP++)
+        for(int iLo = 0; iLo < nLo; iLo++){
+            long long i = (long long) iP * nLo + iLo;
+            lArRef   [i] = ReferenceSurvivalProba(lDecayType, lArP[iP], lArLo[iLo]);
+            lArPairP [i] = lArP [iP];
+            lArPairLo[i] = lArLo[iLo];
+        }
+
+    ComputeSurvivalGrid (lDecayType, &lArP[0], nP, &lArLo[0], nLo, &lArGrid[0]);
+    ComputeSurvivalPairs(lDecayType, &lArPairP[0], &lArPairLo[0], n, &lArPairs[0]);
+
+    // kernels : double precision ; tables : interpolation tolerance
+    const double lAbsTol = 1e-14;
+    const double lRelTol = 1e-11;
+
+    AccuracyStat lStats[nBenchPath];
+    for(long long i = 0; i < n; i++){
+        lStats[kPathExact].Add( ExactSurvivalProba(lDecayType, lArPairP[i], lArPairLo[i]), lArRef[i], lAbsTol, lRelTol );
+        lStats[kPathGrid ].Add( lArGrid [i], lArRef[i], lAbsTol, lRelTol );
+        lStats[kPathPairs].Add( lArPairs[i], lArRef[i], lAbsTol, lRelTol );
+        if(lSet.fTables.size()) lStats[kPathTable].Add( EvalSurvivalTables(lSet, lDecayType, lArPairP[i], lArPairLo[i]), lArRef[i], lTableTol, 0. );
+    }
+
+    int nFail = 0;
+    for(int iPath = 0; iPath < kPathIntegrand; iPath++){
+        if(iPath == kPathTable && !lSet.fTables.size()) continue;
+        PrintAccuracy(gkBenchPathName[iPath], gkDecayChains[lDecayType].fEnumName, ch_Case, lStats[iPath]);
+        nFail += lStats[iPath].fNFail > 0;
+    }
+    return nFail;
+}
+
+// Integral of dProba_dlxi over [0, Lo] (composite 5-point Gauss-Legendre) against the reference :
+// checks the integrand the TF1 quadrature path is built on
+static int CheckIntegrand(short lDecayType, const std::vector<double> &lArP, const std::vector<double> &lArLo){
+
+    static const double lNodes  [5] = { 0., -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640 };
+    static const double lWeights[5] = { 0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891 };
+    const int nPanel = 512;
+
+    AccuracyStat lStat;
+    for(size_t iP = 0; iP < lArP.size(); iP++)
+        for(size_t iLo = 0; iLo < lArLo.size(); iLo++){
+            double par[3] = { lArLo[iLo], lArP[iP], (double) lDecayType };
+            double h      = lArLo[iLo] / nPanel;
+            double lSum   = 0.;
+            for(int iPanel = 0; iPanel < nPanel; iPanel++)
+                for(int iNode = 0; iNode < 5; iNode++){
+                    double x = h * (iPanel + 0.5 + 0.5 * lNodes[iNode]);
+                    lSum += 0.5 * h * lWeights[iNode] * dProba_dlxi(&x, par);
+                }
+            lStat.Add( lSum, ReferenceSurvivalProba(lDecayType, lArP[iP], lArLo[iLo]), 1e-10, 0. );
+        }
+
+    PrintAccuracy("dProba_dlxi+quadrature", gkDecayChains[lDecayType].fEnumName, "grid", lStat);
+    return lStat.fNFail > 0;
+}
+
+// Invalid candidates (p <= 0, Lo < 0, NaN, +-inf) : gkInvalidSurvivalProba from every path but the tables,
+// counted by ComputeSurvivalGrid / ComputeSurvivalPairs ; -0 is a valid Lo. Also meaningful in the SURVIVALPROBA_FAST_MATH build.
+static int CheckInvalidInputs(short lDecayType){
+
+    const double lNaN = std::numeric_limits<double>::quiet_NaN();
+    const double lInf = std::numeric_limits<double>::infinity();
+    const double lArP [] = { 1., 0., -0., -1., lNaN, -lNaN, lInf, -lInf, 1e-300 };
+    const double lArLo[] = { 0.1, -0., 0., -1e-300, -1., lNaN, lInf, -lInf };
+    const int nP  = sizeof(lArP ) / sizeof(double);
+    const int nLo = sizeof(lArLo) / sizeof(double);
+
+    std::vector<double> lArPairP, lArPairLo;
+    for(int iP = 0; iP < nP; iP++)
+        for(int iLo = 0; iLo < nLo; iLo++){
+            lArPairP .push_back( lArP [iP]  );
+            lArPairLo.push_back( lArLo[iLo] );
+        }
+    long long n = lArPairP.size();
+
+    std::vector<double> lArGrid(n), lArPairs(n);
+    long long nInvalidGrid  = -1;
+    long long nInvalidPairs = -1;
+    ComputeSurvivalGrid (lDecayType, lArP, nP, lArLo, nLo, &lArGrid[0], &nInvalidGrid);
+    ComputeSurvivalPairs(lDecayType, &lArPairP[0], &lArPairLo[0], n, &lArPairs[0], &nInvalidPairs);
+
+    // expected : p valid = 1 and a tiny one ; Lo valid = 0.1, -0 and 0
+    long long nExpected = 0;
+    AccuracyStat lStats[nBenchPath];
+    for(long long i = 0; i < n; i++){
+        bool lValid = (lArPairP[i] == 1. || lArPairP[i] == 1e-300) && (lArPairLo[i] == 0.1 || lArPairLo[i] == 0.);
+        nExpected += !lValid;
+        double lValues[3] = { ExactSurvivalProba(lDecayType, lArPairP[i], lArPairLo[i]), lArGrid[i], lArPairs[i] };
+        for(int iPath = kPathExact; iPath <= kPathPairs; iPath++){
+            double x = lValues[iPath - kPathExact];
+            lStats[iPath].fN++;
+            if(lValid ? !(x >= 0. && x <= 1.) : x != gkInvalidSurvivalProba) lStats[iPath].fNFail++;
+        }
+    }
+    if(nInvalidGrid  != nExpected) lStats[kPathGrid ].fNFail++;
+    if(nInvalidPairs != nExpected) lStats[kPathPairs].fNFail++;
+
+    int nFail = 0;
+    for(int iPath = kPathExact; iPath <= kPathPairs; iPath++){
+        PrintAccuracy(gkBenchPathName[iPath], gkDecayChains[lDecayType].fEnumName, "invalid input", lStats[iPath]);
+        nFail += lStats[iPath].fNFail > 0;
+    }
+    return nFail;
+}
+
+// Kernel level : the registry has no species with equal decay constants, a = b . (1 + eps)
+static int CheckEqualLifetimes(){
+
+    const double lArEps[] = { 0., 1e-15, 1e-12, 1e-9, 1e-6, 1e-4, 1e-3, 1e-2, 1e-1 };
+    const double lArA  [] = { 0.1, 1., 10., 1e4 };
+
+    int nFail = 0;
+    for(size_t iEps = 0; iEps < sizeof(lArEps)/sizeof(double); iEps++){
+        AccuracyStat lStat;
+        for(size_t iA = 0; iA < sizeof(lArA)/sizeof(double); iA++){
+            double a = lArA[iA];
+            double b = a * (1. + lArEps[iEps]);
+            for(int iLo = 0; iLo <= 200; iLo++){
+                double Lo = 20. / a * iLo / 200;
+                lStat.Add( CascadeClosedForm(a, b, Lo), ReferenceCascade(a, b, Lo), 1e-14, 1e-11 );
+                lStat.Add( CascadeClosedForm(b, a, Lo), ReferenceCascade(b, a, Lo), 1e-14, 1e-11 );
+            }
+        }
+        char ch_Case[64];
+        snprintf(ch_Case, sizeof(ch_Case), "b=a(1+%g)", lArEps[iEps]);
+        PrintAccuracy("CascadeClosedForm", "-", ch_Case, lStat);
+        nFail += lStat.fNFail > 0;
+    }
+    return nFail;
+}
+
+
+// --- Timing
+
+static double Now(){
+    return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static void TimeSpecies(short lDecayType, int nLo, double lMinTime, const SurvivalTableSet &lSet){
+
+    const DecayChainInfo &lInfo = gkDecayChains[lDecayType];
+    const int nP = 3;
+    long long n  = (long long) nP * nLo;
+
+    std::vector<double> lArLo(nLo), lArPairP(n), lArPairLo(n), lArOut(n);
+    for(int iLo = 0; iLo < nLo; iLo++) lArLo[iLo] = lInfo.fLoMax / nLo * iLo;
+    for(long long i = 0; i < n; i++){
+        lArPairP [i] = lInfo.fPCases[i / nLo];
+        lArPairLo[i] = lArLo[i % nLo];
+    }
+
+    for(int iPath = 0; iPath < nBenchPath; iPath++){
+        if(iPath == kPathTable && !lSet.fTables.size()) continue;
+
+        long long nRep   = 0;
+        double    lStart = Now();
+        double    lTime  = 0.;
+        do{
+            double lSum = 0.;
+            switch(iPath){
+                case kPathExact :
+                    for(long long i = 0; i < n; i++) lSum += ExactSurvivalProba(lDecayType, lArPairP[i], lArPairLo[i]);
+                    break;
+                case kPathGrid :
+                    ComputeSurvivalGrid(lDecayType, lInfo.fPCases, nP, &lArLo[0], nLo, &lArOut[0]);
+                    lSum = lArOut[n-1];
+                    break;
+                case kPathPairs :
+                    ComputeSurvivalPairs(lDecayType, &lArPairP[0], &lArPairLo[0], n, &lArOut[0]);
+                    lSum = lArOut[n-1];
+                    break;
+                case kPathTable :
+                    for(long long i = 0; i < n; i++) lSum += EvalSurvivalTables(lSet, lDecayType, lArPairP[i], lArPairLo[i]);
+                    break;
+                case kPathIntegrand :
+                    for(long long i = 0; i < n; i++){
+                        double par[3] = { lInfo.fLoMax, lArPairP[i], (double) lDecayType };
+                        lSum += dProba_dlxi(&lArPairLo[i], par);
+                    }
+                    break;
+            }
+            gBenchSink = gBenchSink + lSum;
+            nRep++;
+            lTime = Now() - lStart;
+        }while(lTime < lMinTime);
+
+        fprintf(gBenchFile, "timing,%s,%s,%dx%d,%lld,%.4g,,,ok\n", gkBenchPathName[iPath], lInfo.fEnumName, nP, nLo, n, nRep * n / lTime);
+    }
+}
+
+
+int main(int argc, char **argv){
+
+    std::vector<int>    lTypes;
+    std::vector<int>    lArN;
+    double              lMinTime    = 0.05;
+    const char         *ch_Table    = "SurvivalProbaTables.bin";
+    double              lTolerance  = 1e-5;
+    bool                lDoTiming   = true;
+    const char         *ch_Output   = 0;
+
+    for(int iArg = 1; iArg < argc; iArg++){
+        std::string lArg(argv[iArg]);
+
+        if(lArg == "-h" || lArg == "--help"){ PrintUsage(argv[0]); return 0; }
+        if(lArg == "--no-timing"){ lDoTiming = false; continue; }
+        if(iArg + 1 >= argc){
+            fprintf(stderr, "survivalproba_bench : unknown option or missing value for %s\n", lArg.c_str());
+            return 1;
+        }
+        const char *ch_Value = argv[++iArg];
+
+        if(lArg == "-t" || lArg == "--type"){
+            int lType = FindDecayType(ch_Value);
+            if(lType < 0){ fprintf(stderr, "survivalproba_bench : unknown species %s\n", ch_Value); return 1; }
+            lTypes.push_back(lType);
+        }
+        else if(lArg == "-n" || lArg == "--npoint"){
+            if(!ParseSizes(ch_Value, lArN)){ fprintf(stderr, "survivalproba_bench : wrong size list %s\n", ch_Value); return 1; }
+        }
+        else if(lArg == "--min-time"){
+            if(!ParseReal(ch_Value, lMinTime) || !(lMinTime > 0.)){ fprintf(stderr, "survivalproba_bench : wrong minimal time %s, > 0 s\n", ch_Value); return 1; }
+        }
+        else if(lArg == "--table")                      ch_Table    = ch_Value;
+        else if(lArg == "--tolerance"){
+            if(!ParseReal(ch_Value, lTolerance) || !(lTolerance >= gkSurvivalTableMinTolerance)){
+                fprintf(stderr, "survivalproba_bench : wrong tolerance %s, >= %g (float values)\n", ch_Value, gkSurvivalTableMinTolerance); return 1;
+            }
+        }
+        else if(lArg == "-o" || lArg == "--output")     ch_Output   = ch_Value;
+        else{
+            fprintf(stderr, "survivalproba_bench : unknown option %s\n", lArg.c_str());
+            return 1;
+        }
+    }// end loop arguments
+
+    if(lTypes.empty()) for(int iPart = 0; iPart < nPartDecayType; iPart++) lTypes.push_back(iPart);
+    if(lArN  .empty()){ lArN.push_back(100); lArN.push_back(500); lArN.push_back(10000); lArN.push_back(1000000); }
+
+    gBenchFile = ch_Output ? fopen(ch_Output, "w") : stdout;
+    if(!gBenchFile){
+        fprintf(stderr, "survivalproba_bench : cannot open %s\n", ch_Output);
+        return 2;
+    }
+
+    SurvivalTableSet lSet;
+    if( !OpenSurvivalTables(lSet, ch_Table, lTolerance) )
+        fprintf(stderr, "survivalproba_bench : no tables, EvalSurvivalTables skipped\n");
+
+    fprintf(gBenchFile, "record,path,type,case,n,evals_per_sec,max_abs_err,max_rel_err,status\n");
+
+
+    // Accuracy
+    int nFail = CheckEqualLifetimes();
+
+    for(size_t iType = 0; iType < lTypes.size(); iType++){
+        short                 lDecayType = lTypes[iType];
+        const DecayChainInfo &lInfo      = gkDecayChains[lDecayType];
+
+        // registry momenta, Lo in [0, LoMax] as the figures
+        std::vector<double> lArP( lInfo.fPCases, lInfo.fPCases + 3 );
+        std::vector<double> lArLo;
+        for(int iLo = 0; iLo < 500; iLo++) lArLo.push_back( lInfo.fLoMax / 500 * iLo );
+        nFail += CheckSpecies(lDecayType, "grid", lArP, lArLo, lSet, lTolerance);
+
+        if(lInfo.fDaughterPFraction > 0.){
+            std::vector<double> lArLoQuad;
+            for(int iLo = 1; iLo <= 50; iLo++) lArLoQuad.push_back( lInfo.fLoMax / 50 * iLo );
+            nFail += CheckIntegrand(lDecayType, lArP, lArLoQuad);
+        }
+
+        // edge cases, over a wide momentum range
+        double lArPWide[] = { 0.1, 0.5, 2., 10., 100. };
+        lArP.assign( lArPWide, lArPWide + 5 );
+
+        nFail += CheckSpecies(lDecayType, "L0=0", lArP, std::vector<double>(1, 0.), lSet, lTolerance);
+
+        double lArLoLarge[] = { 10., 1e3, 1e6, 1e300 };
+        nFail += CheckSpecies(lDecayType, "large L0", lArP, std::vector<double>(lArLoLarge, lArLoLarge + 4), lSet, lTolerance);
+
+        // Lo up to 20 mean decay lengths of the slowest case : micrometres for the D mesons
+        double lScale = 20. * lInfo.fCTau * lArPWide[0] / lInfo.fMass;
+        lArLo.clear();
+        for(int iLo = 0; iLo < 1000; iLo++) lArLo.push_back( lScale / 1000 * iLo );
+        nFail += CheckSpecies(lDecayType, "decay-length scale", lArP, lArLo, lSet, lTolerance);
+
+        nFail += CheckInvalidInputs(lDecayType);
+    }
+
+
+    // Timing
+    if(lDoTiming)
+        for(size_t iType = 0; iType < lTypes.size(); iType++)
+            for(size_t iN = 0; iN < lArN.size(); iN++)
+                TimeSpecies(lTypes[iType], lArN[iN], lMinTime, lSet);
+
+    CloseSurvivalTables(lSet);
+
+    if(ferror(gBenchFile)) return 2;
+    if(gBenchFile != stdout) fclose(gBenchFile);
+
+    if(nFail) fprintf(stderr, "survivalproba_bench : %d accuracy check(s) failed\n", nFail);
+    return nFail ? 3 : 0;
+}
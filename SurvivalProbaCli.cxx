@@ -0,0 +1,269 @@
+// survivalproba : command line tool on top of the SurvivalProba library, without ROOT.
+//
+// Computes P(L>Lo) curves (one per species and momentum) and writes them as CSV or binary,
+// or builds the lookup-table cache used by OpenSurvivalTables().
+//
+//   survivalproba                                  all species, registry momenta, CSV on stdout
+//   survivalproba -t kLambdaFromXi -p 1,3,8 -n 1000 -o xi.csv
+//   survivalproba -f bin -o curves.bin             binary : 4 float64 per point (gkDecayType, p, Lo, P), 5 with --mc (+ error)
+//   survivalproba --table SurvivalProbaTables.bin --tolerance 1e-5
+//   survivalproba -t kLambdaFromXi -p 3 --mc 100000000 --ymax 0.5     toy MC, with statistical errors
+//   survivalproba -t kLambdaFromXi --mc 1000000000 --temperature 0.3  averaged over an mT-exponential spectrum
+
+#include "SurvivalProba.h"
+#include "SurvivalProbaMC.h"
+
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+static void PrintUsage(const char *ch_Name){
+    printf("Usage : %s [options]\n", ch_Name);
+    printf("  -t, --type NAME       species, e.g. kLambdaFromXi (repeatable, default : all)\n");
+    printf("  -p, --p LIST          comma-separated momenta in GeV/c (default : registry momenta of each species)\n");
+    printf("  -L, --lomax X         upper edge of Lo in m (default : registry value of each species)\n");
+    printf("  -n, --npoint N        number of Lo points per curve (default : 500)\n");
+    printf("  -f, --format FMT      csv (default) or bin (4 float64 per point : gkDecayType, p, Lo, P)\n");
+    printf("  -o, --output FILE     output file (default : stdout)\n");
+    printf("  -j, --threads N       number of threads, 0 = all cores (default : 0)\n");
+    printf("      --table FILE      build the lookup-table cache in FILE if missing or stale, then exit\n");
+    printf("      --tolerance X     absolute interpolation tolerance of the tables, >= 1e-7 (default : 1e-5)\n");
+    printf("      --mc N            toy Monte Carlo with N decays per curve ; CSV/bin get an error column\n");
+    printf("                        (--temperature, --ymax, --collinear and --seed need --mc)\n");
+    printf("      --temperature T   MC : mT-exponential spectrum of slope T in GeV, pT in [0, 10] GeV/c (default : fixed pT = p)\n");
+    printf("      --ymax Y          MC : rapidity flat in [-Y, Y] (default : 0)\n");
+    printf("      --collinear       MC : cascade daughter along the mother, as in the analytic calculation\n");
+    printf("      --seed S          MC : seed of the counter-based generator (default : 1)\n");
+    printf("  -h, --help\n");
+    printf("Species :");
+    for(int iPart = 0; iPart < nPartDecayType; iPart++) printf(" %s", gkDecayChains[iPart].fEnumName);
+    printf("\n");
+}
+
+static bool ParseMomenta(const char *ch_List, std::vector<double> &lArP){
+    std::string lList(ch_List);
+    size_t lStart = 0;
+    while(lStart <= lList.size()){
+        size_t lEnd = lList.find(',', lStart);
+        if(lEnd == std::string::npos) lEnd = lList.size();
+        char *lParsed = 0;
+        std::string lItem = lList.substr(lStart, lEnd - lStart);
+        double p = strtod(lItem.c_str(), &lParsed);
+        if(lItem.empty() || *lParsed != '\0' || !(p > 0.)) return false;
+        lArP.push_back(p);
+        lStart = lEnd + 1;
+    }
+    return !lArP.empty();
+}
+
+// Whole argument parsed as a finite real / a non-negative integer, as for the momenta : no silent atof/atoi
+static bool ParseReal(const char *ch_Value, double &lValue){
+    char *lParsed = 0;
+    double x = strtod(ch_Value, &lParsed);
+    if(lParsed == ch_Value || *lParsed != '\0' || !std::isfinite(x)) return false;
+    lValue = x;
+    return true;
+}
+
+static bool ParseCount(const char *ch_Value, long long lMax, long long &lValue){
+    char *lParsed = 0;
+    errno = 0;
+    long long n = strtoll(ch_Value, &lParsed, 10);
+    if(lParsed == ch_Value || *lParsed != '\0' || errno == ERANGE || n < 0 || n > lMax) return false;
+    lValue = n;
+    return true;
+}
+
+int main(int argc, char **argv){
+    
+    std::vector<int>    lTypes;
+    std::vector<double> lArP;
+    double              LoMax       = -1;
+    int                 lNbPoint    = 500;
+    std::string         Str_Format  = "csv";
+    const char         *ch_Output   = 0;
+    int                 lNThreads   = 0;
+    const char         *ch_Table    = 0;
+    double              lTolerance  = 1e-5;
+    long long           lNDecays    = 0;
+    double              lTemperature= -1;
+    double              lYMax       = 0.;
+    bool                lCollinear  = false;
+    uint64_t            lSeed       = 1;
+    const char         *ch_MCOption = 0;    // last MC-only option given, meaningless without --mc
+    long long           lCount      = 0;
+    
+    for(int iArg = 1; iArg < argc; iArg++){
+        std::string lArg(argv[iArg]);
+        bool lHasValue = iArg + 1 < argc;
+        
+        if(lArg == "-h" || lArg == "--help"){ PrintUsage(argv[0]); return 0; }
+        if(lArg == "--collinear"){ lCollinear = true; ch_MCOption = argv[iArg]; continue; }
+        if(!lHasValue){
+            fprintf(stderr, "survivalproba : unknown option or missing value for %s\n", lArg.c_str());
+            return 1;
+        }
+        const char *ch_Value = argv[++iArg];
+        
+        if(lArg == "-t" || lArg == "--type"){
+            int lType = FindDecayType(ch_Value);
+            if(lType < 0){ fprintf(stderr, "survivalproba : unknown species %s\n", ch_Value); return 1; }
+            lTypes.push_back(lType);
+        }
+        else if(lArg == "-p" || lArg == "--p"){
+            if(!ParseMomenta(ch_Value, lArP)){ fprintf(stderr, "survivalproba : wrong momentum list %s\n", ch_Value); return 1; }
+        }
+        else if(lArg == "-L" || lArg == "--lomax"){
+            if(!ParseReal(ch_Value, LoMax) || !(LoMax > 0.)){ fprintf(stderr, "survivalproba : wrong Lo upper edge %s, > 0 m\n", ch_Value); return 1; }
+        }
+        else if(lArg == "-n" || lArg == "--npoint"){
+            if(!ParseCount(ch_Value, INT_MAX, lCount) || lCount == 0){ fprintf(stderr, "survivalproba : wrong number of points %s\n", ch_Value); return 1; }
+            lNbPoint = (int) lCount;
+        }
+        else if(lArg == "-f" || lArg == "--format")     Str_Format  = ch_Value;
+        else if(lArg == "-o" || lArg == "--output")     ch_Output   = ch_Value;
+        else if(lArg == "-j" || lArg == "--threads"){
+            if(!ParseCount(ch_Value, INT_MAX, lCount)){ fprintf(stderr, "survivalproba : wrong number of threads %s, >= 0\n", ch_Value); return 1; }
+            lNThreads = (int) lCount;
+        }
+        else if(lArg == "--table")                      ch_Table    = ch_Value;
+        else if(lArg == "--tolerance"){
+            if(!ParseReal(ch_Value, lTolerance) || !(lTolerance >= gkSurvivalTableMinTolerance)){
+                fprintf(stderr, "survivalproba : wrong tolerance %s, >= %g (float values)\n", ch_Value, gkSurvivalTableMinTolerance); return 1;
+            }
+        }
+        else if(lArg == "--mc"){
+            if(!ParseCount(ch_Value, gkMCMaxDecays, lNDecays) || lNDecays == 0){
+                fprintf(stderr, "survivalproba : wrong number of decays %s, in [1, %lld]\n", ch_Value, gkMCMaxDecays); return 1;
+            }
+        }
+        else if(lArg == "--temperature"){
+            if(!ParseReal(ch_Value, lTemperature) || !(lTemperature > 0.)){ fprintf(stderr, "survivalproba : wrong temperature %s, > 0 GeV\n", ch_Value); return 1; }
+            ch_MCOption = argv[iArg - 1];
+        }
+        else if(lArg == "--ymax"){
+            if(!ParseReal(ch_Value, lYMax) || !(lYMax >= 0.)){ fprintf(stderr, "survivalproba : wrong rapidity range %s, >= 0\n", ch_Value); return 1; }
+            ch_MCOption = argv[iArg - 1];
+        }
+        else if(lArg == "--seed"){
+            if(!ParseCount(ch_Value, LLONG_MAX, lCount)){ fprintf(stderr, "survivalproba : wrong seed %s, >= 0\n", ch_Value); return 1; }
+            lSeed = (uint64_t) lCount;
+            ch_MCOption = argv[iArg - 1];
+        }
+        else{
+            fprintf(stderr, "survivalproba : unknown option %s\n", lArg.c_str());
+            return 1;
+        }
+    }// end loop arguments
+    
+    if(ch_MCOption && lNDecays == 0){
+        fprintf(stderr, "survivalproba : %s only applies to the toy Monte Carlo, give --mc N\n", ch_MCOption);
+        return 1;
+    }
+    
+    if(ch_Table){
+        SurvivalTableSet lSet;
+        if( !OpenSurvivalTables(lSet, ch_Table, lTolerance) ) return 2;
+        CloseSurvivalTables(lSet);
+        return 0;
+    }
+    
+    if(lNbPoint <= 0 || (Str_Format != "csv" && Str_Format != "bin")){
+        fprintf(stderr, "survivalproba : wrong number of points or format\n");
+        return 1;
+    }
+    
+    if(lTypes.empty()) for(int iPart = 0; iPart < nPartDecayType; iPart++) lTypes.push_back(iPart);
+    
+    
+    // Curves : one task per (species, momentum)
+    std::vector<SurvivalTask> lTasks;
+    for(size_t iType = 0; iType < lTypes.size(); iType++){
+        const DecayChainInfo &lInfo = gkDecayChains[lTypes[iType]];
+        std::vector<double> lArPType( lArP );
+        if(lArPType.empty()) lArPType.assign( lInfo.fPCases, lInfo.fPCases + 3 );
+        if(lNDecays > 0 && lTemperature > 0.) lArPType.assign(1, 0.);       // one spectrum-averaged curve, p = 0
+        
+        for(size_t ipTCase = 0; ipTCase < lArPType.size(); ipTCase++){
+            SurvivalTask lTask;
+            lTask.fDecayType = lTypes[iType];
+            lTask.fPtCase    = ipTCase;
+            lTask.fP         = lArPType[ipTCase];
+            lTask.fLoMax     = (LoMax > 0.) ? LoMax : lInfo.fLoMax;
+            lTask.fArLo   .assign(lNbPoint, 0.);
+            lTask.fArProba.assign(lNbPoint, 0.);
+            lTask.fStatus    = -1;
+            lTasks.push_back(lTask);
+        }
+    }
+    
+    // Toy MC instead of the analytic calculation : the threads go to the decays, curve after curve
+    std::vector< std::vector<double> > lArErrors;
+    if(lNDecays > 0){
+        for(size_t iTask = 0; iTask < lTasks.size(); iTask++){
+            SurvivalTask &lTask = lTasks[iTask];
+            MCConfig lConfig;
+            lConfig.fDecayType = lTask.fDecayType;
+            lConfig.fSpectrum  = (lTemperature > 0.) ? MakeMtExponentialSpectrum(gkDecayChains[lTask.fDecayType].fMass, lTemperature, 0., 10., 1000, -lYMax, lYMax)
+                                                     : MakeFixedPtSpectrum(lTask.fP, -lYMax, lYMax);
+            lConfig.fLoMax     = lTask.fLoMax;
+            lConfig.fNbPoint   = lNbPoint;
+            lConfig.fNDecays   = lNDecays;
+            lConfig.fSeed      = lSeed;
+            lConfig.fNThreads  = lNThreads;
+            lConfig.fCollinear = lCollinear;
+            
+            MCSurvivalCurve lCurve;
+            if( !SimulateSurvivalProba(lConfig, lCurve) ){
+                fprintf(stderr, "survivalproba : simulation failed\n");
+                return 2;
+            }
+            lTask.fArLo    = lCurve.fArLo;
+            lTask.fArProba = lCurve.fArProba;
+            lTask.fStatus  = 1;
+            lArErrors.push_back(lCurve.fArError);
+        }
+    }
+    else if( !RunSurvivalTasks(lTasks, lNThreads) ){
+        fprintf(stderr, "survivalproba : computation failed\n");
+        return 2;
+    }
+    
+    
+    // Output
+    bool  lIsBinary = (Str_Format == "bin");
+    FILE *lFile     = ch_Output ? fopen(ch_Output, lIsBinary ? "wb" : "w") : stdout;
+    if(!lFile){
+        fprintf(stderr, "survivalproba : cannot open %s\n", ch_Output);
+        return 2;
+    }
+    
+    bool lHasError = !lArErrors.empty();
+    int  lNbColumn = lHasError ? 5 : 4;
+    if(!lIsBinary) fprintf(lFile, lHasError ? "type,p,L0,P,error\n" : "type,p,L0,P\n");
+    
+    for(size_t iTask = 0; iTask < lTasks.size(); iTask++){
+        const SurvivalTask &lTask = lTasks[iTask];
+        for(int iPoint = 0; iPoint < lNbPoint; iPoint++){
+            double lError = lHasError ? lArErrors[iTask][iPoint] : 0.;
+            if(lIsBinary){
+                double lRecord[5] = { (double) lTask.fDecayType, lTask.fP, lTask.fArLo[iPoint], lTask.fArProba[iPoint], lError };
+                fwrite(lRecord, sizeof(double), lNbColumn, lFile);
+            }
+            else if(lHasError)
+                fprintf(lFile, "%s,%.6g,%.9g,%.9g,%.3g\n", gkDecayChains[lTask.fDecayType].fEnumName, lTask.fP, lTask.fArLo[iPoint], lTask.fArProba[iPoint], lError);
+            else
+                fprintf(lFile, "%s,%.6g,%.9g,%.9g\n", gkDecayChains[lTask.fDecayType].fEnumName, lTask.fP, lTask.fArLo[iPoint], lTask.fArProba[iPoint]);
+        }
+    }
+    
+    int lStatus = ferror(lFile) ? 2 : 0;
+    if(lFile != stdout && fclose(lFile)) lStatus = 2;
+    return lStatus;
+}
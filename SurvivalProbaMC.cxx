@@ -0,0 +1,290 @@
+// Toy Monte Carlo of the decay chains, to validate the analytic survival probabilities (see SurvivalProbaMC.h)
+
+#include "SurvivalProbaMC.h"
+#include "SurvivalProba.h"
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+
+static const int        gkMCBatchSize   = 4096;         // decays per SoA batch
+static const double     gkTwoPi         = 6.283185307179586;
+
+
+static inline void Philox4x32_10(uint32_t c[4], uint32_t k0, uint32_t k1){
+
+    // Salmon et al., "Parallel random numbers : as easy as 1, 2, 3" (SC11) ; c is replaced by the output
+
+    for(int iRound = 0; iRound < 10; iRound++){
+        uint64_t p0 = (uint64_t) 0xD2511F53u * c[0];
+        uint64_t p1 = (uint64_t) 0xCD9E8D57u * c[2];
+        uint32_t c0 = (uint32_t)(p1 >> 32) ^ c[1] ^ k0;
+        uint32_t c2 = (uint32_t)(p0 >> 32) ^ c[3] ^ k1;
+        c[1] = (uint32_t) p1;
+        c[3] = (uint32_t) p0;
+        c[0] = c0;
+        c[2] = c2;
+        k0  += 0x9E3779B9u;
+        k1  += 0xBB67AE85u;
+    }
+}
+
+static inline double ToUniform(uint32_t x){
+    return (x + 0.5) * (1. / 4294967296.);     // in ]0, 1[ : safe for the log
+}
+
+
+// Structure-of-arrays buffers of one batch of decays
+struct MCBatch{
+    std::vector<double> fU[8];      // uniform random numbers, 8 per decay
+    std::vector<double> fRBorn;     // transverse radius where the particle of interest is created
+    std::vector<double> fRDecay;    //   "        "       where it decays
+
+    MCBatch(){
+        for(int iU = 0; iU < 8; iU++) fU[iU].resize(gkMCBatchSize);
+        fRBorn .resize(gkMCBatchSize);
+        fRDecay.resize(gkMCBatchSize);
+    }
+};
+
+// Run-time constants of one simulation
+struct MCSetup{
+    const MCConfig     *fConfig;
+    std::vector<double> fCdf;           // cumulative spectrum weights, normalised to 1
+    double              fMass;
+    double              fCTau;
+    bool                fIsCascade;
+    double              fMassDaughter;
+    double              fCTauDaughter;
+    double              fPFraction;
+    double              fPStar;         // daughter momentum in the mother rest frame
+    double              fEStar;
+    double              fDLo;
+};
+
+static double SamplePt(const MCSetup &lSetup, double u){
+
+    const std::vector<double> &lCdf   = lSetup.fCdf;
+    const std::vector<double> &lEdges = lSetup.fConfig->fSpectrum.fPtEdges;
+
+    size_t iBin = std::upper_bound(lCdf.begin(), lCdf.end(), u) - lCdf.begin();
+    if(iBin >= lCdf.size()) iBin = lCdf.size() - 1;
+
+    double lLow   = iBin ? lCdf[iBin-1] : 0.;
+    double lWidth = lCdf[iBin] - lLow;
+    double lFrac  = lWidth > 0. ? (u - lLow) / lWidth : 0.5;
+    return lEdges[iBin] + lFrac * (lEdges[iBin+1] - lEdges[iBin]);
+}
+
+static void SimulateBatch(const MCSetup &lSetup, long long iFirst, int n, MCBatch &lBatch, std::vector<long long> &lDiff){
+
+    const MCConfig &lConfig = *lSetup.fConfig;
+
+    // 1. random numbers : counter = global decay index, key = seed
+    uint32_t k0 = (uint32_t)  lConfig.fSeed;
+    uint32_t k1 = (uint32_t) (lConfig.fSeed >> 32);
+    for(int i = 0; i < n; i++){
+        uint64_t iDecay = iFirst + i;
+        for(int iCall = 0; iCall < 2; iCall++){
+            uint32_t c[4] = { (uint32_t) iDecay, (uint32_t)(iDecay >> 32), (uint32_t) iCall, 0u };
+            Philox4x32_10(c, k0, k1);
+            for(int j = 0; j < 4; j++) lBatch.fU[4*iCall + j][i] = ToUniform(c[j]);
+        }
+    }
+
+    // 2. kinematics and decay points
+    double lYMin = lConfig.fSpectrum.fYMin;
+    double lDY   = lConfig.fSpectrum.fYMax - lConfig.fSpectrum.fYMin;
+
+    for(int i = 0; i < n; i++){
+
+        double pT  = SamplePt(lSetup, lBatch.fU[0][i]);
+        double y   = lYMin + lDY * lBatch.fU[1][i];
+        double phi = gkTwoPi * lBatch.fU[2][i];
+
+        double mT  = std::sqrt(lSetup.fMass * lSetup.fMass + pT * pT);
+        double px  = pT * std::cos(phi);
+        double py  = pT * std::sin(phi);
+        double pz  = mT * std::sinh(y);
+        double E   = mT * std::cosh(y);
+
+        // decay point = (p/m) . proper decay length . (px, py, pz)/p : the norm cancels out
+        double l1  = -lSetup.fCTau * std::log(lBatch.fU[3][i]) / lSetup.fMass;
+        double x1  = l1 * px;
+        double y1  = l1 * py;
+        double R1  = l1 * pT;
+
+        if(!lSetup.fIsCascade){
+            lBatch.fRBorn [i] = 0.;
+            lBatch.fRDecay[i] = R1;
+            continue;
+        }
+
+        double qx, qy, qz;
+        if(lConfig.fCollinear){
+            qx = lSetup.fPFraction * px;
+            qy = lSetup.fPFraction * py;
+            qz = lSetup.fPFraction * pz;
+        }
+        else{
+            // isotropic two-body decay in the rest frame, boosted along the mother momentum
+            double lCos = 2. * lBatch.fU[4][i] - 1.;
+            double lSin = std::sqrt( std::max(0., 1. - lCos * lCos) );
+            double lPhi = gkTwoPi * lBatch.fU[5][i];
+            double sx   = lSetup.fPStar * lSin * std::cos(lPhi);
+            double sy   = lSetup.fPStar * lSin * std::sin(lPhi);
+            double sz   = lSetup.fPStar * lCos;
+
+            double lGamma = E / lSetup.fMass;
+            double bx     = px / E;
+            double by     = py / E;
+            double bz     = pz / E;
+            double lBP    = bx * sx + by * sy + bz * sz;
+            double lF     = lGamma * ( lGamma / (lGamma + 1.) * lBP + lSetup.fEStar );
+            qx = sx + lF * bx;
+            qy = sy + lF * by;
+            qz = sz + lF * bz;
+        }
+
+        // as for the mother, (q/m) . cTau . (qx, qy, qz)/q : the norm cancels out
+        double l2  = -lSetup.fCTauDaughter * std::log(lBatch.fU[6][i]) / lSetup.fMassDaughter;
+        double x2  = x1 + l2 * qx;
+        double y2  = y1 + l2 * qy;
+        (void) qz;
+
+        lBatch.fRBorn [i] = R1;
+        lBatch.fRDecay[i] = std::sqrt(x2 * x2 + y2 * y2);
+    }
+
+    // 3. counts : alive at Lo(k) = k.dLo  <=>  RBorn <= Lo(k) < RDecay, as a difference array over k
+    int    lNbPoint = lConfig.fNbPoint;
+    double lInvDLo  = 1. / lSetup.fDLo;
+    for(int i = 0; i < n; i++){
+        double s = std::ceil( lBatch.fRBorn [i] * lInvDLo );
+        double e = std::ceil( lBatch.fRDecay[i] * lInvDLo );
+        int    iStart = s < lNbPoint ? (int) s : lNbPoint;
+        int    iEnd   = e < lNbPoint ? (int) e : lNbPoint;
+        if(iStart >= iEnd) continue;
+        lDiff[iStart]++;
+        lDiff[iEnd]--;
+    }
+}
+
+MCSpectrum MakeFixedPtSpectrum(double pT, double yMin, double yMax){
+    MCSpectrum lSpectrum;
+    lSpectrum.fPtEdges.assign(2, pT);
+    lSpectrum.fWeights.assign(1, 1.);
+    lSpectrum.fYMin = yMin;
+    lSpectrum.fYMax = yMax;
+    return lSpectrum;
+}
+
+MCSpectrum MakeMtExponentialSpectrum(double lMass, double lTemperature,
+                                     double pTMin, double pTMax, int nBins,
+                                     double yMin, double yMax){
+
+    // Tabulated at the bin centres, pT flat inside a bin
+
+    MCSpectrum lSpectrum;
+    lSpectrum.fYMin = yMin;
+    lSpectrum.fYMax = yMax;
+
+    for(int iBin = 0; iBin <= nBins; iBin++) lSpectrum.fPtEdges.push_back( pTMin + (pTMax - pTMin) * iBin / nBins );
+    for(int iBin = 0; iBin <  nBins; iBin++){
+        double pT = 0.5 * (lSpectrum.fPtEdges[iBin] + lSpectrum.fPtEdges[iBin+1]);
+        double mT = std::sqrt(lMass * lMass + pT * pT);
+        lSpectrum.fWeights.push_back( pT * std::exp( -(mT - lMass) / lTemperature ) * (lSpectrum.fPtEdges[iBin+1] - lSpectrum.fPtEdges[iBin]) );
+    }
+    return lSpectrum;
+}
+
+int SimulateSurvivalProba(const MCConfig &lConfig, MCSurvivalCurve &lCurve){
+
+    if(lConfig.fDecayType < 0 || lConfig.fDecayType >= nPartDecayType){
+        fprintf(stderr, "SimulateSurvivalProba : wrong particle type [%d]... exit !\n", lConfig.fDecayType);
+        return 0;
+    }
+    const MCSpectrum &lSpectrum = lConfig.fSpectrum;
+    if(lSpectrum.fWeights.empty() || lSpectrum.fPtEdges.size() != lSpectrum.fWeights.size() + 1 ||
+       lConfig.fNbPoint <= 0 || !(lConfig.fLoMax > 0.) || lConfig.fNDecays <= 0 || lConfig.fNDecays > gkMCMaxDecays){
+        fprintf(stderr, "SimulateSurvivalProba : wrong configuration... exit !\n");
+        return 0;
+    }
+
+    const DecayChainInfo &lInfo = gkDecayChains[lConfig.fDecayType];
+
+    MCSetup lSetup;
+    lSetup.fConfig        = &lConfig;
+    lSetup.fMass          = lInfo.fMass;
+    lSetup.fCTau          = lInfo.fCTau;
+    lSetup.fIsCascade     = lInfo.fDaughterPFraction > 0.;
+    lSetup.fMassDaughter  = lInfo.fMassDaughter;
+    lSetup.fCTauDaughter  = lInfo.fCTauDaughter;
+    lSetup.fPFraction     = lInfo.fDaughterPFraction;
+    lSetup.fDLo           = lConfig.fLoMax / lConfig.fNbPoint;
+    lSetup.fPStar         = 0.;
+    lSetup.fEStar         = 0.;
+    if(lSetup.fIsCascade){
+        double M  = lInfo.fMass;
+        double m1 = lInfo.fMassDaughter;
+        double m2 = lInfo.fMassBachelor;
+        lSetup.fPStar = std::sqrt( (M*M - (m1+m2)*(m1+m2)) * (M*M - (m1-m2)*(m1-m2)) ) / (2. * M);
+        lSetup.fEStar = std::sqrt( lSetup.fPStar * lSetup.fPStar + m1 * m1 );
+    }
+
+    double lSum = 0.;
+    for(size_t iBin = 0; iBin < lSpectrum.fWeights.size(); iBin++){
+        lSum += std::max(0., lSpectrum.fWeights[iBin]);
+        lSetup.fCdf.push_back(lSum);
+    }
+    if(!(lSum > 0.)){
+        fprintf(stderr, "SimulateSurvivalProba : empty spectrum... exit !\n");
+        return 0;
+    }
+    for(size_t iBin = 0; iBin < lSetup.fCdf.size(); iBin++) lSetup.fCdf[iBin] /= lSum;
+
+
+    // Threads : chunks of decays picked from a shared counter, one difference array per thread
+    long long lNChunks  = lConfig.fNDecays / gkMCChunkSize + (lConfig.fNDecays % gkMCChunkSize != 0);
+    int       lNThreads = lConfig.fNThreads > 0 ? lConfig.fNThreads : (int) std::thread::hardware_concurrency();
+    if(lNThreads <= 0) lNThreads = 1;
+    if(lNThreads > lNChunks) lNThreads = lNChunks;
+
+    std::vector<std::vector<long long> > lDiffs(lNThreads, std::vector<long long>(lConfig.fNbPoint + 1, 0));
+    std::atomic<long long> lNextChunk(0);
+
+    auto lWorker = [&](int iThread){
+        MCBatch lBatch;
+        for(long long iChunk = lNextChunk++; iChunk < lNChunks; iChunk = lNextChunk++){
+            long long iEnd = iChunk * gkMCChunkSize + std::min( gkMCChunkSize, lConfig.fNDecays - iChunk * gkMCChunkSize );
+            for(long long iFirst = iChunk * gkMCChunkSize; iFirst < iEnd; iFirst += gkMCBatchSize)
+                SimulateBatch(lSetup, iFirst, (int) std::min( (long long) gkMCBatchSize, iEnd - iFirst ), lBatch, lDiffs[iThread]);
+        }
+    };
+
+    std::vector<std::thread> lThreads;
+    for(int iThread = 1; iThread < lNThreads; iThread++) lThreads.push_back( std::thread(lWorker, iThread) );
+    lWorker(0);
+    for(size_t iThread = 0; iThread < lThreads.size(); iThread++) lThreads[iThread].join();
+
+
+    // Curve
+    lCurve.fNDecays = lConfig.fNDecays;
+    lCurve.fArLo   .assign(lConfig.fNbPoint, 0.);
+    lCurve.fArProba.assign(lConfig.fNbPoint, 0.);
+    lCurve.fArError.assign(lConfig.fNbPoint, 0.);
+
+    long long lCount = 0;
+    for(int iPoint = 0; iPoint < lConfig.fNbPoint; iPoint++){
+        for(int iThread = 0; iThread < lNThreads; iThread++) lCount += lDiffs[iThread][iPoint];
+        double P = (double) lCount / lConfig.fNDecays;
+        lCurve.fArLo   [iPoint] = lConfig.fLoMax / lConfig.fNbPoint * iPoint;
+        lCurve.fArProba[iPoint] = P;
+        lCurve.fArError[iPoint] = std::sqrt( P * (1. - P) / lConfig.fNDecays );
+    }
+
+    return 1;
+}
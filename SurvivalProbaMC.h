@@ -0,0 +1,63 @@
+#ifndef SURVIVALPROBAMC_H
+#define SURVIVALPROBAMC_H
+
+// Toy Monte Carlo of the decay chains of the registry (SurvivalProba.h), to validate the analytic
+// survival probabilities beyond their hypotheses : momentum spectrum instead of a single momentum,
+// rapidity range instead of y = 0, two-body decay kinematics instead of a fixed momentum fraction.
+//
+// The mother is generated from (pT, y, phi), pT following a tabulated spectrum, y flat in [fYMin, fYMax].
+// Proper decay lengths are exponential with mean cTau ; for the cascades, the Lambda comes from an
+// isotropic two-body decay in the mother rest frame, boosted to the lab. Straight lines, no field.
+// The survival probability at Lo is the fraction of decays for which the particle of interest
+// (the Lambda for the cascades) is alive at the transverse radius Lo : it is born inside Lo
+// (Lambda : the mother decayed at R < Lo) and decays outside (R >= Lo).
+// At y = 0 with fCollinear, the Lambda carries fDaughterPFraction of the mother momentum along its
+// direction : the result is then the analytic one, up to the statistical error.
+//
+// Random numbers : Philox4x32-10 counter-based generator, the counter being the global decay index
+// and the key the seed. Each decay has its own stream, so the result does not depend on the number
+// of threads nor on the scheduling (the counts are integers, merged exactly).
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+
+const long long gkMCChunkSize = 1 << 20;                        // decays per scheduling unit of the threads
+const long long gkMCMaxDecays = LLONG_MAX - gkMCChunkSize;      // upper bound of MCConfig::fNDecays
+
+struct MCSpectrum{
+    std::vector<double> fPtEdges;   // GeV/c, nBins + 1 ; a bin of zero width = fixed pT
+    std::vector<double> fWeights;   // nBins, arbitrary normalisation
+    double              fYMin;
+    double              fYMax;
+};
+
+struct MCConfig{
+    short               fDecayType;     // gkDecayType
+    MCSpectrum          fSpectrum;
+    double              fLoMax;         // in m
+    int                 fNbPoint;       // Lo values : fLoMax/fNbPoint * iPoint, as the analytic curves
+    long long           fNDecays;       // in [1, gkMCMaxDecays]
+    uint64_t            fSeed;
+    int                 fNThreads;      // 0 = all cores
+    bool                fCollinear;     // cascades : daughter along the mother, with fDaughterPFraction
+};
+
+struct MCSurvivalCurve{
+    std::vector<double> fArLo;          // in m
+    std::vector<double> fArProba;       // P(L>Lo), averaged over the spectrum
+    std::vector<double> fArError;       // binomial statistical error
+    long long           fNDecays;
+};
+
+MCSpectrum MakeFixedPtSpectrum(double pT, double yMin = 0., double yMax = 0.);
+
+MCSpectrum MakeMtExponentialSpectrum(double lMass, double lTemperature,            // dN/dpT ~ pT exp(-mT/T)
+                                     double pTMin, double pTMax, int nBins,
+                                     double yMin = -0.5, double yMax = 0.5);
+
+int SimulateSurvivalProba(const MCConfig &lConfig, MCSurvivalCurve &lCurve);
+
+
+#endif // SURVIVALPROBAMC_H